@@ -93,6 +93,13 @@ namespace oops
         t_out{FMT, "oops[tag-%d, depth-%d] = no oops\n", data.tag_,
                    data.depth_};
     }
+#ifdef DAINTY_OOPS_BREADCRUMB
+    for (auto ix = info.crumbs_.size(); ix--; ) {
+      const t_crumb& crumb = info.crumbs_[ix];
+      t_out{FMT, "  <- %s:%d, depth-%d\n", get(crumb.file_), crumb.line_,
+                 crumb.depth_};
+    }
+#endif
   }
 
   t_void trace_step_in(R_info info, p_what what, P_void context, R_data1 data) {
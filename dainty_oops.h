@@ -89,7 +89,8 @@
 //     3. default policy will do nothing when an ignorable error is set.
 //
 //     note: you can write your own context class, or provide your own
-//           policy and/or printing functions.
+//           policy and/or printing functions (t_ctxt) or types that can
+//           keep state (t_functor_ctxt).
 //
 //
 // additional notes:
@@ -110,6 +111,8 @@
 //       - must handle at some point otherwise abort.
 //       - must handle up the callstack.
 //       - can only hold one error at a time.
+//         a shared context (t_shared_ctxt) keeps the first error that is
+//         published by parallel workers and drops the others.
 //       - can only be cleared when set to void overuse of clear().
 //       - can separate "normal" from the "error handling" using
 //         deferred error handling that is innate to the use of t_oops.
@@ -123,15 +126,32 @@
 //       - defer to t_ctxt(temnplate) so behaviour, policy can change without
 //          chaning existing code.
 //
-// two flags:
+// flags:
 //
 //   DAINTY_OOPS_BASIC  - only weak enforcement required.
 //                 reduce t_oops use overhead, and no debug possible.
 //   DAINTY_OOPS_TRACE  - track and print use path of owner
+//   DAINTY_OOPS_FAULT  - mark_block can publish configured errors.
+//                 see dainty_oops_fault.h.
+//   DAINTY_OOPS_STATS  - count publish and clear per domain and id in a
+//                 memory mapped file. see dainty_oops_stats.h.
+//   DAINTY_OOPS_PROFILE - attribute cycles between mark_block calls to
+//                 blocks. see dainty_oops_profile.h.
+//   DAINTY_OOPS_BREADCRUMB - the context keeps the mark_block sites of the
+//                 active call chain and freezes them into t_info on publish.
 //
 
 #include "dainty_named_assert.h"
 #include "dainty_oops_ctxt.h"
+#ifdef DAINTY_OOPS_FAULT
+#include "dainty_oops_fault.h"
+#endif
+#ifdef DAINTY_OOPS_STATS
+#include "dainty_oops_stats.h"
+#endif
+#ifdef DAINTY_OOPS_PROFILE
+#include "dainty_oops_profile.h"
+#endif
 
 namespace dainty
 {
@@ -152,6 +172,7 @@ namespace oops
 
   private:
     template<p_what, class, class> friend class t_oops;
+    template<p_what, class, class> friend class t_slim_oops;
     P_void ctxt_;
   };
 
@@ -163,6 +184,9 @@ namespace oops
   #include "dainty_oops_user.h"
 #endif
 
+  template<p_what W = default_what, class I = t_id, class C = DAINTY_OOPS_CTXT>
+  class t_slim_oops;
+
   template<p_what W = default_what, class I = t_id, class C = DAINTY_OOPS_CTXT>
   class t_oops {
   public:
@@ -174,6 +198,8 @@ namespace oops
     t_oops(const t_oops&);
     template<p_what W1, class I1, class C1>
     t_oops(const t_oops<W1, I1, C1>&);
+    template<p_what W1, class I1, class C1>
+    t_oops(const t_slim_oops<W1, I1, C1>&);
     t_oops(p_ctxt);
     ~t_oops();
 
@@ -199,10 +225,101 @@ namespace oops
 
   private:
     template<p_what, class, class> friend class t_oops;
+    template<p_what, class, class> friend class t_slim_oops;
     t_oops& operator=(const t_oops&); // = delete
 
+    template<t_bool> struct t_shared_ { };
+    using t_is_shared_ = t_shared_<t_ctxt_shared<C>::VALUE>;
+
+    t_info get_info_(R_info) const;
+
+    t_bool publish_(t_id,   t_shared_<false>);
+    t_bool publish_(R_info, t_shared_<false>);
+    t_bool publish_(t_id,   t_shared_<true>);
+    t_bool publish_(R_info, t_shared_<true>);
+
     p_ctxt ctxt_;
     t_data data_;
+#ifdef DAINTY_OOPS_PROFILE
+    t_probe probe_;
+#endif
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+
+  // t_slim_oops: a non-owning t_oops that is trivially copyable and 16 bytes
+  // (context pointer and t_slim_data), so it is passed by value in
+  // registers. it has the set/clear/tag semantics of a t_oops frame, but it
+  // does not remember the file of mark_block and does not trace step_out.
+  //
+  // the copy must stay trivial, so a copy is the same frame: it keeps the
+  // depth and the set flag, and can clear what the frame published. pass
+  // oops.deeper() to a callee, it is a new frame one level deeper and has
+  // the clear rules of t_oops: it cannot clear what its caller published.
+  // the conversion from a t_oops or another t_slim_oops type goes one level
+  // deeper too. a slim handle publishes one level below its own depth, so
+  // the frame that handed on the handle can clear what its callee published.
+  //
+  //   t_void leaf(t_slim_oops<what> oops) {
+  //     if (DAINTY_OOPS_BLOCK_GUARD(oops))
+  //       oops = 1;
+  //   }
+  //   t_void node(t_slim_oops<what> oops) {
+  //     leaf(oops.deeper());
+  //     if (oops)
+  //       oops.clear();
+  //   }
+
+  template<p_what W, class I, class C>
+  class t_slim_oops {
+  public:
+    using t_ctxt = typename named::t_prefix<C>::t_;
+    using p_ctxt = typename named::t_prefix<C>::p_;
+    using R_id   = typename named::t_prefix<I>::R_;
+
+    template<p_what W1, class I1, class C1>
+    t_slim_oops(const t_oops<W1, I1, C1>&);
+    template<p_what W1, class I1, class C1>
+    t_slim_oops(const t_slim_oops<W1, I1, C1>&);
+
+    t_slim_oops deeper() const;
+
+    t_slim_oops& mark_block(P_filename, t_lineno);
+    t_slim_oops& tag       (t_tagid);
+
+    t_slim_oops& operator=(R_id);
+    t_slim_oops& operator=(R_info);
+
+    t_info  clear();
+
+    operator t_validity() const;
+    operator t_bool    () const;
+    t_id     id        () const;
+    t_tagid  tag       () const;
+    t_bool   is_set    (r_info) const;
+    P_cstr   what      () const;
+    t_void   print     () const;
+
+    t_bool knows(const t_except&) const;
+
+  private:
+    template<p_what, class, class> friend class t_oops;
+    template<p_what, class, class> friend class t_slim_oops;
+
+    template<t_bool> struct t_shared_ { };
+    using t_is_shared_ = t_shared_<t_ctxt_shared<C>::VALUE>;
+
+    t_slim_oops(p_ctxt, t_depth);
+    t_data get_data_(t_depth = 0) const;
+    t_info get_info_(R_info) const;
+
+    t_bool publish_(t_id,   t_shared_<false>);
+    t_bool publish_(R_info, t_shared_<false>);
+    t_bool publish_(t_id,   t_shared_<true>);
+    t_bool publish_(R_info, t_shared_<true>);
+
+    p_ctxt      ctxt_;
+    t_slim_data data_;
   };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -241,6 +358,20 @@ namespace oops
 #endif
   }
 
+  template<p_what W,  typename I,  typename C>
+  template<p_what W1, typename I1, typename C1>
+  inline
+  t_oops<W,I,C>::t_oops(const t_slim_oops<W1, I1, C1>& oops)
+#ifndef DAINTY_OOPS_BASIC
+    : ctxt_(oops.ctxt_), data_(false, false, oops.data_.depth_ + 1) {
+#else
+    : ctxt_(oops.ctxt_), data_(false, false) {
+#endif
+#ifdef DAINTY_OOPS_TRACE
+    ctxt_->step_in(data_, W);
+#endif
+  }
+
   template<p_what W, typename I, typename C>
   inline
   t_oops<W,I,C>::t_oops(const t_oops& oops)
@@ -259,6 +390,12 @@ namespace oops
   t_oops<W,I,C>::~t_oops() {
 #ifdef DAINTY_OOPS_TRACE
     ctxt_->step_out(data_, W);
+#endif
+#ifdef DAINTY_OOPS_PROFILE
+    probe_out(probe_, id());
+#endif
+#if defined(DAINTY_OOPS_BREADCRUMB) && !defined(DAINTY_OOPS_BASIC)
+    ctxt_->uncrumb(data_.depth_);
 #endif
     if (data_.owner_) {
       const t_bool on = id();
@@ -317,16 +454,9 @@ namespace oops
   template<p_what W, typename I, typename C>
   inline
   t_oops<W,I,C>& t_oops<W,I,C>::operator=(R_id value) {
-    if (value) {
-      const t_bool on = id();
-      if (!on) {
-#ifndef DAINTY_OOPS_BASIC
-        data_.set_ = true;
-#endif
-        ctxt_->set(value, W, data_);
-      } else
-        assert_now(P_cstr{"oops->already_set"});
-    } else
+    if (value)
+      publish_(value, t_is_shared_());
+    else
       assert_now(P_cstr{"oops->use_clear"});
     return *this;
   }
@@ -334,29 +464,112 @@ namespace oops
   template<p_what W, typename I, typename C>
   inline
   t_oops<W,I,C>& t_oops<W,I,C>::operator=(R_info info) {
-    if (info.id_ && info.what_) {
-      const t_bool on = id();
-      if (!on) {
-#ifndef DAINTY_OOPS_BASIC
-        data_.set_ = true;
-#endif
-        ctxt_->set(info);
-      } else
-        assert_now(P_cstr{"oops->already_set"});
-    } else
+    if (info.id_ && info.what_)
+      publish_(info, t_is_shared_());
+    else
       assert_now(P_cstr{"oops->invalid_info"});
     return *this;
   }
 
+  template<p_what W, typename I, typename C>
+  inline
+  t_bool t_oops<W,I,C>::publish_(t_id value, t_shared_<false>) {
+    const t_bool on = id();
+    if (!on) {
+#ifndef DAINTY_OOPS_BASIC
+      data_.set_ = true;
+#endif
+      ctxt_->set(value, W, data_);
+#ifdef DAINTY_OOPS_STATS
+      stats_publish(ctxt_->get_info());
+#endif
+      return true;
+    }
+    assert_now(P_cstr{"oops->already_set"});
+    return false;
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_info t_oops<W,I,C>::get_info_(R_info info) const {
+    t_info tmp(info); // the context and depth are of this frame
+    tmp.ctxt_  = ctxt_;
+#ifndef DAINTY_OOPS_BASIC
+    tmp.depth_ = data_.depth_;
+#else
+    tmp.depth_ = 0;
+#endif
+    return tmp;
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_bool t_oops<W,I,C>::publish_(R_info info, t_shared_<false>) {
+    const t_bool on = id();
+    if (!on) {
+#ifndef DAINTY_OOPS_BASIC
+      data_.set_ = true;
+#endif
+      ctxt_->set(get_info_(info));
+#ifdef DAINTY_OOPS_STATS
+      stats_publish(ctxt_->get_info());
+#endif
+      return true;
+    }
+    assert_now(P_cstr{"oops->already_set"});
+    return false;
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_bool t_oops<W,I,C>::publish_(t_id value, t_shared_<true>) {
+    if (ctxt_->set(value, W, data_)) {
+#ifndef DAINTY_OOPS_BASIC
+      data_.set_ = true;
+#endif
+#ifdef DAINTY_OOPS_STATS
+      stats_publish(ctxt_->get_info());
+#endif
+      return true;
+    }
+    return false; // another thread published first
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_bool t_oops<W,I,C>::publish_(R_info info, t_shared_<true>) {
+    if (ctxt_->set(get_info_(info))) {
+#ifndef DAINTY_OOPS_BASIC
+      data_.set_ = true;
+#endif
+#ifdef DAINTY_OOPS_STATS
+      stats_publish(ctxt_->get_info());
+#endif
+      return true;
+    }
+    return false; // another thread published first
+  }
+
   template<p_what W, typename I, typename C>
   inline
   t_oops<W,I,C>& t_oops<W,I,C>::mark_block(P_filename file, t_lineno line) {
+#ifdef DAINTY_OOPS_PROFILE
+    probe_block(probe_, file, line, id());
+#endif
 #ifndef DAINTY_OOPS_BASIC
     data_.file_ = file;
     data_.line_ = line;
+#ifdef DAINTY_OOPS_BREADCRUMB
+    ctxt_->crumb(file, line, data_.depth_);
+#endif
 #endif
 #ifdef DAINTY_OOPS_TRACE
     ctxt_->step_do(data_, W);
+#endif
+#ifdef DAINTY_OOPS_FAULT
+    const t_id fault = inject_fault(W, file, line, data_.tag_);
+    if (fault && !id())
+      publish_(fault, t_is_shared_());
 #endif
     return *this;
   }
@@ -380,7 +593,13 @@ namespace oops
       assert_now(P_cstr{"oops->cannot_be_cleared"});
     data_.set_ = false;
 #endif
+#ifdef DAINTY_OOPS_STATS
+    const t_info info = ctxt_->clear();
+    stats_clear(info);
+    return info;
+#else
     return ctxt_->clear();
+#endif
   }
 
   template<p_what W, typename I, typename C>
@@ -388,6 +607,250 @@ namespace oops
   t_bool t_oops<W,I,C>::knows(const t_except& except) const {
     return ctxt_ == except.ctxt_;
   }
+
+////////////////////////////////////////////////////////////////////////////////
+
+  template<p_what W,  typename I,  typename C>
+  template<p_what W1, typename I1, typename C1>
+  inline
+  t_slim_oops<W,I,C>::t_slim_oops(const t_oops<W1, I1, C1>& oops)
+#ifndef DAINTY_OOPS_BASIC
+    : t_slim_oops(oops.ctxt_, oops.data_.depth_ + 1) {
+#else
+    : t_slim_oops(oops.ctxt_, 0) {
+#endif
+  }
+
+  template<p_what W,  typename I,  typename C>
+  template<p_what W1, typename I1, typename C1>
+  inline
+  t_slim_oops<W,I,C>::t_slim_oops(const t_slim_oops<W1, I1, C1>& oops)
+    : t_slim_oops(oops.ctxt_, oops.data_.depth_ + 1) {
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_slim_oops<W,I,C>::t_slim_oops(p_ctxt ctxt, t_depth depth)
+    : ctxt_(ctxt), data_{depth, 0, 0, false} {
+#ifdef DAINTY_OOPS_TRACE
+    ctxt_->step_in(get_data_(), W);
+#endif
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_slim_oops<W,I,C> t_slim_oops<W,I,C>::deeper() const {
+    return t_slim_oops(ctxt_, data_.depth_ + 1);
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_data t_slim_oops<W,I,C>::get_data_(t_depth below) const {
+#ifndef DAINTY_OOPS_BASIC
+    t_data data(false, false, data_.depth_ + below);
+    data.set_  = data_.set_;
+    data.line_ = data_.line_;
+#else
+    t_data data(false, false);
+    static_cast<t_void>(below);
+#endif
+    data.tag_ = data_.tag_;
+    return data;
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_info t_slim_oops<W,I,C>::get_info_(R_info info) const {
+    t_info tmp(info);
+    tmp.ctxt_  = ctxt_;
+#ifndef DAINTY_OOPS_BASIC
+    tmp.depth_ = data_.depth_ + 1;
+#else
+    tmp.depth_ = 0;
+#endif
+    return tmp;
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_slim_oops<W,I,C>::operator t_validity() const {
+    return ctxt_ ? VALID : INVALID;
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_slim_oops<W,I,C>::operator t_bool() const {
+    return id();
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_id t_slim_oops<W,I,C>::id() const {
+    return ctxt_->get_id();
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_tagid t_slim_oops<W,I,C>::tag() const {
+    return data_.tag_;
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_bool t_slim_oops<W,I,C>::is_set(r_info info) const {
+    const t_bool on = id();
+    if (on)
+      info = ctxt_->get_info();
+    return on;
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  P_cstr t_slim_oops<W,I,C>::what() const {
+    return ctxt_->what();
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  void t_slim_oops<W,I,C>::print() const {
+    ctxt_->print(get_data_());
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_slim_oops<W,I,C>& t_slim_oops<W,I,C>::operator=(R_id value) {
+    if (value)
+      publish_(value, t_is_shared_());
+    else
+      assert_now(P_cstr{"oops->use_clear"});
+    return *this;
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_slim_oops<W,I,C>& t_slim_oops<W,I,C>::operator=(R_info info) {
+    if (info.id_ && info.what_)
+      publish_(info, t_is_shared_());
+    else
+      assert_now(P_cstr{"oops->invalid_info"});
+    return *this;
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_bool t_slim_oops<W,I,C>::publish_(t_id value, t_shared_<false>) {
+    const t_bool on = id();
+    if (!on) {
+      data_.set_ = true;
+#ifdef DAINTY_OOPS_BREADCRUMB
+      ctxt_->uncrumb(data_.depth_ + 1);
+#endif
+      ctxt_->set(value, W, get_data_(1));
+#ifdef DAINTY_OOPS_STATS
+      stats_publish(ctxt_->get_info());
+#endif
+      return true;
+    }
+    assert_now(P_cstr{"oops->already_set"});
+    return false;
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_bool t_slim_oops<W,I,C>::publish_(R_info info, t_shared_<false>) {
+    const t_bool on = id();
+    if (!on) {
+      data_.set_ = true;
+      ctxt_->set(get_info_(info));
+#ifdef DAINTY_OOPS_STATS
+      stats_publish(ctxt_->get_info());
+#endif
+      return true;
+    }
+    assert_now(P_cstr{"oops->already_set"});
+    return false;
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_bool t_slim_oops<W,I,C>::publish_(t_id value, t_shared_<true>) {
+    if (ctxt_->set(value, W, get_data_(1))) {
+      data_.set_ = true;
+#ifdef DAINTY_OOPS_STATS
+      stats_publish(ctxt_->get_info());
+#endif
+      return true;
+    }
+    return false; // another thread published first
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_bool t_slim_oops<W,I,C>::publish_(R_info info, t_shared_<true>) {
+    if (ctxt_->set(get_info_(info))) {
+      data_.set_ = true;
+#ifdef DAINTY_OOPS_STATS
+      stats_publish(ctxt_->get_info());
+#endif
+      return true;
+    }
+    return false; // another thread published first
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_slim_oops<W,I,C>& t_slim_oops<W,I,C>::mark_block(P_filename file,
+                                                     t_lineno line) {
+    data_.line_ = line;
+#ifdef DAINTY_OOPS_BREADCRUMB
+    ctxt_->crumb(file, line, data_.depth_);
+#endif
+#ifdef DAINTY_OOPS_TRACE
+    ctxt_->step_do(get_data_(), W);
+#endif
+#ifdef DAINTY_OOPS_FAULT
+    const t_id fault = inject_fault(W, file, line, data_.tag_);
+    if (fault && !id())
+      publish_(fault, t_is_shared_());
+#else
+    static_cast<t_void>(file);
+#endif
+    return *this;
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_slim_oops<W,I,C>& t_slim_oops<W,I,C>::tag(t_tagid tag) {
+    if (!id())
+      data_.tag_ = tag;
+    return *this;
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_info t_slim_oops<W,I,C>::clear() {
+    if (!id())
+      assert_now(P_cstr{"oops->nothing_to_clear"});
+#ifndef DAINTY_OOPS_BASIC
+    const t_depth depth = ctxt_->get_depth();
+    if (data_.depth_ > depth || (data_.depth_ == depth && !data_.set_))
+      assert_now(P_cstr{"oops->cannot_be_cleared"});
+#endif
+    data_.set_ = false;
+#ifdef DAINTY_OOPS_STATS
+    const t_info info = ctxt_->clear();
+    stats_clear(info);
+    return info;
+#else
+    return ctxt_->clear();
+#endif
+  }
+
+  template<p_what W, typename I, typename C>
+  inline
+  t_bool t_slim_oops<W,I,C>::knows(const t_except& except) const {
+    return ctxt_ == except.ctxt_;
+  }
 }
 }
 
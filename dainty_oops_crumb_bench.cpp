@@ -0,0 +1,149 @@
+/******************************************************************************
+
+ MIT License
+
+ Copyright (c) 2018 kieme, frits.germs@gmx.net
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+******************************************************************************/
+
+// usage: dainty_oops_crumb_bench [depth] [rounds]
+//
+//   build with DAINTY_OOPS_BREADCRUMB. add DAINTY_OOPS_BENCH_LIBUNWIND and
+//   link -lunwind to compare with unw_backtrace() as well.
+//
+//   a recursion of depth frames, every round ends in a capture at the
+//   deepest frame, in ns per round, with the number of frames captured:
+//
+//     plain:     the recursion without t_oops and without capture.
+//     backtrace: plain, the deepest frame calls backtrace().
+//     unwind:    plain, the deepest frame calls unw_backtrace().
+//     happy:     a t_oops and a mark_block per frame, no error. this is the
+//                cost of keeping the crumbs (push and step_out).
+//     crumbs:    happy, the deepest frame publishes and freezes the crumbs,
+//                the root clears.
+
+#include <chrono>
+#include <cstdlib>
+#include <execinfo.h>
+#ifdef DAINTY_OOPS_BENCH_LIBUNWIND
+#define UNW_LOCAL_ONLY
+#include <libunwind.h>
+#endif
+#include "dainty_named_terminal.h"
+#include "dainty_oops.h"
+
+#ifndef DAINTY_OOPS_BREADCRUMB
+#error "build with DAINTY_OOPS_BREADCRUMB"
+#endif
+
+using namespace dainty::named::terminal;
+using namespace dainty::oops;
+
+namespace
+{
+  using t_clock = std::chrono::steady_clock;
+
+  enum { MAX_FRAMES = 256 };
+
+  t_def what(t_id id) {
+    return id ? t_def{IGNORE, P_cstr{"failed"}}
+              : t_def{IGNORE, P_cstr{"bench"}};
+  }
+
+  using t_bench_oops = t_oops<what>;
+
+  enum t_capture { NONE, BACKTRACE, UNWIND };
+
+  void* frames_[MAX_FRAMES];
+
+  int plain_(unsigned, t_capture);
+
+  // called through a volatile pointer, so the recursion stays a recursion.
+  int (* volatile next_)(unsigned, t_capture) = plain_;
+
+  __attribute__((noinline))
+  int plain_(unsigned level, t_capture capture) {
+    if (level > 1) {
+      int frames = next_(level - 1, capture);
+      asm volatile("" : "+r"(frames)); // no tail call, keep the frame
+      return frames;
+    }
+    if (capture == BACKTRACE)
+      return backtrace(frames_, MAX_FRAMES);
+#ifdef DAINTY_OOPS_BENCH_LIBUNWIND
+    if (capture == UNWIND)
+      return unw_backtrace(frames_, MAX_FRAMES);
+#endif
+    return 0;
+  }
+
+  __attribute__((noinline))
+  t_void oops_(const t_bench_oops& parent, unsigned level, t_bool fail) {
+    t_bench_oops oops(parent);
+    if (DAINTY_OOPS_BLOCK_GUARD(oops)) {
+      if (level > 1)
+        oops_(oops, level - 1, fail);
+      else if (fail)
+        oops = 1;
+    }
+  }
+
+  template<class F>
+  void run_(const char* name, unsigned rounds, F body) {
+    long sink = body(); // warm up, backtrace() loads its unwinder
+    const auto start = t_clock::now();
+    for (unsigned round = 0; round < rounds; ++round)
+      sink += body();
+    const std::chrono::duration<double, std::nano> ns =
+      t_clock::now() - start;
+    t_out{FMT, "%-10s %10.1f %8ld\n", name, ns.count() / rounds,
+               sink / (rounds + 1)};
+  }
+}
+
+int main(int argc, char* argv[]) {
+  const unsigned depth  = argc > 1 ? std::atoi(argv[1]) : 32;
+  const unsigned rounds = argc > 2 ? std::atoi(argv[2]) : 100000;
+
+  t_out{FMT, "depth = %u, rounds = %u, crumbs = %d\n", depth, rounds,
+             MAX_CRUMBS};
+  t_out{FMT, "capture     ns/round   frames\n"};
+
+  run_("plain", rounds, [&] { return plain_(depth, NONE); });
+  run_("backtrace", rounds, [&] { return plain_(depth, BACKTRACE); });
+#ifdef DAINTY_OOPS_BENCH_LIBUNWIND
+  run_("unwind", rounds, [&] { return plain_(depth, UNWIND); });
+#endif
+
+  t_ctxt<> ctxt;
+  t_bench_oops root(&ctxt);
+  run_("happy", rounds, [&] {
+    oops_(root, depth, false);
+    return 0;
+  });
+  run_("crumbs", rounds, [&] {
+    oops_(root, depth, true);
+    const int frames = ctxt.get_info().crumbs_.size();
+    root.clear();
+    return frames;
+  });
+  return 0;
+}
@@ -27,6 +27,7 @@
 #ifndef _DAINTY_OOPS_CTXT_H_
 #define _DAINTY_OOPS_CTXT_H_
 
+#include <type_traits>
 #include "dainty_named.h"
 
 namespace dainty
@@ -81,6 +82,14 @@ namespace oops
     P_filename    file_;
   };
 
+  // t_slim_oops keeps its frame in one small word, no file and no owner.
+  struct t_slim_data {
+    t_depth  depth_;
+    t_tagid  tag_;
+    t_lineno line_;
+    t_bool   set_;
+  };
+
   struct t_def {
     t_category category_;
     P_cstr     string_;
@@ -95,6 +104,73 @@ namespace oops
 
   typedef t_def (*p_what)(t_id);
 
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef DAINTY_OOPS_BREADCRUMB
+  // breadcrumbs: the last mark_block site of every depth of the active call
+  // chain. a mark_block at depth d drops the crumbs of depth >= d, and so
+  // does the step_out of a t_oops at depth d, so frames that returned
+  // disappear. a t_slim_oops has no step_out: it drops the crumbs below its
+  // own depth when it publishes. when more than MAX_CRUMBS depths are active
+  // the outermost crumbs are dropped. on publish, the crumbs up to the
+  // publishing depth are frozen into the t_info.
+
+  enum { MAX_CRUMBS = 8 }; // power of 2
+
+  struct t_crumb {
+    t_crumb() : file_(nullptr), line_(0), depth_(0) { }
+    t_crumb(P_filename file, t_lineno line, t_depth depth)
+      : file_(file), line_(line), depth_(depth) { }
+
+    P_filename file_;
+    t_lineno   line_;
+    t_depth    depth_;
+  };
+
+  struct t_crumbs {
+    t_crumbs() : head_(0), n_(0) { }
+
+    inline const t_crumb& operator[](named::t_uint8 ix) const {
+      return crumb_[(head_ + ix) & (MAX_CRUMBS - 1)];
+    }
+
+    inline named::t_uint8 size() const {
+      return n_;
+    }
+
+    inline t_void drop(t_depth depth) {
+      while (n_ && (*this)[n_ - 1].depth_ >= depth)
+        --n_;
+    }
+
+    inline t_void push(P_filename file, t_lineno line, t_depth depth) {
+      drop(depth);
+      if (n_ == MAX_CRUMBS) {
+        head_ = (head_ + 1) & (MAX_CRUMBS - 1);
+        --n_;
+      }
+      crumb_[(head_ + n_++) & (MAX_CRUMBS - 1)] = t_crumb{file, line, depth};
+    }
+
+    inline t_void freeze(const t_crumbs& live, t_depth depth) {
+      head_ = 0;
+      n_    = 0;
+      for (named::t_uint8 ix = 0; ix < live.n_ && live[ix].depth_ <= depth;)
+        crumb_[n_++] = live[ix++];
+    }
+
+    inline t_void reset() {
+      head_ = 0;
+      n_    = 0;
+    }
+
+  private:
+    t_crumb        crumb_[MAX_CRUMBS];
+    named::t_uint8 head_;
+    named::t_uint8 n_;
+  };
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 
   struct t_info {
@@ -114,6 +190,9 @@ namespace oops
     }
 
     inline t_info& reset() {
+#ifdef DAINTY_OOPS_BREADCRUMB
+      crumbs_.reset();
+#endif
       return set(0, 0, 0, 0, P_cstr{nullptr}, 0);
     }
 
@@ -124,6 +203,9 @@ namespace oops
     t_tagid    tag_;
     P_filename file_;
     t_lineno   line_;
+#ifdef DAINTY_OOPS_BREADCRUMB
+    t_crumbs   crumbs_;
+#endif
   };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -171,10 +253,66 @@ namespace oops
 
 ////////////////////////////////////////////////////////////////////////////////
 
-  template<p_policy A = default_policy, p_print P = default_print>
-  class t_ctxt {
+  // a context that may be shared by threads specializes t_ctxt_shared. its
+  // set functions return if they won, and t_oops drops a losing publish
+  // instead of asserting on it. see dainty_oops_shared_ctxt.h.
+
+  template<class C>
+  struct t_ctxt_shared {
+    enum { VALUE = false };
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+
+  // t_functor_ctxt: the context with policy A and printer P as types.
+  //
+  //   A is called as a(R_info) and P as p(R_info, R_data) const. they can be
+  //   function pointers, functors or lambdas that are held by the context,
+  //   so they can keep per context state. empty types take no space and
+  //   their calls can be inlined.
+  //
+  //     struct t_count_policy {
+  //       t_void operator()(R_info info) { ++n_; default_policy(info); }
+  //       named::t_uint32 n_ = 0;
+  //     };
+  //     using t_my_ctxt = t_functor_ctxt<t_count_policy, t_print_fn<>>;
+  //
+  //   types that have no default constructor, like lambdas, are passed to
+  //   the constructor, and the t_oops is created with that context. plain
+  //   function pointer types must be passed too, a default would be null:
+  //   their default construction does not compile.
+
+  template<class T, int N, t_bool = std::is_empty<T>::value>
+  struct t_hold_ : private T {
+    t_hold_(const T& value) : T(value)  { }
+          T& get()       { return *this; }
+    const T& get() const { return *this; }
+  };
+
+  template<class T, int N>
+  struct t_hold_<T, N, false> {
+    t_hold_(const T& value) : value_(value) { }
+          T& get()       { return value_; }
+    const T& get() const { return value_; }
+    T value_;
+  };
+
+  template<p_policy A = default_policy>
+  struct t_policy_fn {
+    t_void operator()(R_info info) const { A(info); }
+  };
+
+  template<p_print P = default_print>
+  struct t_print_fn {
+    t_void operator()(R_info info, R_data data) const { P(info, data); }
+  };
+
+  template<class A, class P>
+  class t_functor_ctxt : private t_hold_<A, 0>, private t_hold_<P, 1> {
   public:
-    t_ctxt();
+    t_functor_ctxt();
+    explicit t_functor_ctxt(A policy);
+    t_functor_ctxt(A policy, P print);
 
     void set(t_id, p_what, R_data1);
     void set(t_id, p_what, R_data2);
@@ -194,97 +332,174 @@ namespace oops
     void step_out(R_data, p_what);
     void step_do (R_data, p_what);
 
+#ifdef DAINTY_OOPS_BREADCRUMB
+    void crumb  (P_filename, t_lineno, t_depth);
+    void uncrumb(t_depth);
+#endif
+
+    A&       get_policy();
+    const A& get_policy() const;
+    const P& get_print () const;
+
   private:
     t_info info_;
+#ifdef DAINTY_OOPS_BREADCRUMB
+    t_crumbs crumbs_;
+#endif
   };
 
 ////////////////////////////////////////////////////////////////////////////////
 
-  template<p_policy A, p_print P>
+  template<class A, class P>
+  inline
+  t_functor_ctxt<A, P>::t_functor_ctxt()
+    : t_hold_<A, 0>(A()), t_hold_<P, 1>(P()), info_(this) {
+    static_assert(!std::is_pointer<A>::value && !std::is_pointer<P>::value,
+                  "a function pointer policy or printer must be passed");
+  }
+
+  template<class A, class P>
+  inline
+  t_functor_ctxt<A, P>::t_functor_ctxt(A policy)
+    : t_hold_<A, 0>(policy), t_hold_<P, 1>(P()), info_(this) {
+    static_assert(!std::is_pointer<P>::value,
+                  "a function pointer printer must be passed");
+  }
+
+  template<class A, class P>
   inline
-  t_ctxt<A, P>::t_ctxt() : info_(this) {
+  t_functor_ctxt<A, P>::t_functor_ctxt(A policy, P print)
+    : t_hold_<A, 0>(policy), t_hold_<P, 1>(print), info_(this) {
   }
 
-  template<p_policy A, p_print P>
+  template<class A, class P>
   inline
-  t_void t_ctxt<A, P>::set(t_id id, p_what what, R_data1 data) {
-    A(info_.set(id, what, 0, data.tag_, P_cstr{nullptr}, 0));
+  A& t_functor_ctxt<A, P>::get_policy() {
+    return t_hold_<A, 0>::get();
   }
 
-  template<p_policy A, p_print P>
+  template<class A, class P>
   inline
-  t_void t_ctxt<A, P>::set(t_id id, p_what what, R_data2 data) {
-    A(info_.set(id, what, data.depth_, data.tag_, data.file_, data.line_));
+  const A& t_functor_ctxt<A, P>::get_policy() const {
+    return t_hold_<A, 0>::get();
   }
 
-  template<p_policy A, p_print P>
+  template<class A, class P>
   inline
-  t_void t_ctxt<A, P>::set(R_info info) {
+  const P& t_functor_ctxt<A, P>::get_print() const {
+    return t_hold_<P, 1>::get();
+  }
+
+  template<class A, class P>
+  inline
+  t_void t_functor_ctxt<A, P>::set(t_id id, p_what what, R_data1 data) {
+#ifdef DAINTY_OOPS_BREADCRUMB
+    info_.crumbs_.freeze(crumbs_, 0);
+#endif
+    get_policy()(info_.set(id, what, 0, data.tag_, P_cstr{nullptr}, 0));
+  }
+
+  template<class A, class P>
+  inline
+  t_void t_functor_ctxt<A, P>::set(t_id id, p_what what, R_data2 data) {
+#ifdef DAINTY_OOPS_BREADCRUMB
+    info_.crumbs_.freeze(crumbs_, data.depth_);
+#endif
+    get_policy()(info_.set(id, what, data.depth_, data.tag_, data.file_,
+                           data.line_));
+  }
+
+  template<class A, class P>
+  inline
+  t_void t_functor_ctxt<A, P>::set(R_info info) {
     info_ = info;
-    A(info_);
+    get_policy()(info_);
   }
 
-  template<p_policy A, p_print P>
+  template<class A, class P>
   inline
-  t_id t_ctxt<A, P>::get_id() const {
+  t_id t_functor_ctxt<A, P>::get_id() const {
     return info_.id_;
   }
 
-  template<p_policy A, p_print P>
+  template<class A, class P>
   inline
-  t_depth t_ctxt<A, P>::get_depth() const {
+  t_depth t_functor_ctxt<A, P>::get_depth() const {
     return info_.depth_;
   }
 
-  template<p_policy A, p_print P>
+  template<class A, class P>
   inline
-  p_what t_ctxt<A, P>::get_what() const {
+  p_what t_functor_ctxt<A, P>::get_what() const {
     return info_.what_;
   }
 
-  template<p_policy A, p_print P>
+  template<class A, class P>
   inline
-  t_info t_ctxt<A, P>::get_info() const {
+  t_info t_functor_ctxt<A, P>::get_info() const {
     return info_;
   }
 
-  template<p_policy A, p_print P>
+  template<class A, class P>
   inline
-  t_void t_ctxt<A, P>::print(R_data data) const {
-    P(info_, data);
+  t_void t_functor_ctxt<A, P>::print(R_data data) const {
+    get_print()(info_, data);
   }
 
-  template<p_policy A, p_print P>
+  template<class A, class P>
   inline
-  P_cstr t_ctxt<A, P>::what() const {
+  P_cstr t_functor_ctxt<A, P>::what() const {
     return info_.what_ ? P_cstr{"no oops"} : info_.what_(info_.id_).string_;
   }
 
-  template<p_policy A, p_print P>
+  template<class A, class P>
   inline
-  t_info t_ctxt<A, P>::clear() {
+  t_info t_functor_ctxt<A, P>::clear() {
     t_info tmp = info_;
     info_.reset();
     return tmp;
   }
 
-  template<p_policy A, p_print P>
+  template<class A, class P>
   inline
-  t_void t_ctxt<A, P>::step_in(R_data data, p_what what) {
+  t_void t_functor_ctxt<A, P>::step_in(R_data data, p_what what) {
     trace_step_in(info_, what, this, data);
   }
 
-  template<p_policy A, p_print P>
+  template<class A, class P>
   inline
-  t_void t_ctxt<A, P>::step_out(R_data data, p_what what) {
+  t_void t_functor_ctxt<A, P>::step_out(R_data data, p_what what) {
     trace_step_out(info_, what, this, data);
   }
 
-  template<p_policy A, p_print P>
+  template<class A, class P>
   inline
-  t_void t_ctxt<A, P>::step_do(R_data data, p_what what) {
+  t_void t_functor_ctxt<A, P>::step_do(R_data data, p_what what) {
     trace_step_do(info_, what, this, data);
   }
+
+#ifdef DAINTY_OOPS_BREADCRUMB
+  template<class A, class P>
+  inline
+  t_void t_functor_ctxt<A, P>::crumb(P_filename file, t_lineno line,
+                                     t_depth depth) {
+    crumbs_.push(file, line, depth);
+  }
+
+  template<class A, class P>
+  inline
+  t_void t_functor_ctxt<A, P>::uncrumb(t_depth depth) {
+    crumbs_.drop(depth);
+  }
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+  // t_ctxt: the context with policy and printer as function pointers.
+
+  template<p_policy A = default_policy, p_print P = default_print>
+  class t_ctxt : public t_functor_ctxt<t_policy_fn<A>, t_print_fn<P>> {
+  };
 }
 }
 
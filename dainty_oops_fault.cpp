@@ -0,0 +1,160 @@
+/******************************************************************************
+
+ MIT License
+
+ Copyright (c) 2018 kieme, frits.germs@gmx.net
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+******************************************************************************/
+
+#include <cstring>
+#include "dainty_oops_fault.h"
+
+namespace dainty
+{
+namespace oops
+{
+  using named::t_uint32;
+  using named::t_uint64;
+
+  std::atomic<t_bool> faults_enabled_{false};
+
+namespace
+{
+  struct t_rule_ {
+    t_id          id_;
+    p_what        what_;
+    const char*   file_;
+    t_lineno      line_;
+    t_tagid       tag_;
+    t_per_million per_million_;
+    t_every       every_;
+  };
+
+  struct t_thread_ {
+    t_uint32 generation_ = 0;
+    t_bool   bound_      = false;
+    t_seed   stream_     = 0;
+    t_uint64 state_      = 0;
+    t_every  hits_[MAX_FAULTS];
+  };
+
+  t_rule_               rules_[MAX_FAULTS];
+  t_uint32              rules_n_ = 0;
+  std::atomic<t_seed>   seed_{0};
+  std::atomic<t_uint32> generation_{1};
+  std::atomic<t_uint32> ordinal_{0};
+
+  thread_local t_thread_ thread_;
+
+  inline t_uint64 splitmix_(t_uint64 x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  inline t_uint64 next_(t_thread_& thread) {
+    t_uint64 x = thread.state_;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    thread.state_ = x;
+    return x * 0x2545f4914f6cdd1dULL;
+  }
+
+  t_void reseed_(t_thread_& thread, t_uint32 generation) {
+    if (!thread.bound_) // unbound streams are above the bound ones
+      thread.stream_ = (1ULL << 63) |
+                       ordinal_.fetch_add(1, std::memory_order_relaxed);
+    thread.generation_ = generation;
+    thread.state_      = splitmix_(seed_.load(std::memory_order_relaxed) +
+                                   splitmix_(thread.stream_)) | 1;
+    for (auto& hits : thread.hits_)
+      hits = 0;
+  }
+
+  inline t_thread_& get_thread_() {
+    const t_uint32 generation = generation_.load(std::memory_order_acquire);
+    if (thread_.generation_ != generation)
+      reseed_(thread_, generation);
+    return thread_;
+  }
+
+  inline t_bool match_file_(const char* rule, const char* file) {
+    return !rule || rule == file || (file && !std::strcmp(rule, file));
+  }
+}
+
+  t_bool add_fault(R_fault fault) {
+    if (rules_n_ == MAX_FAULTS || !fault.id_ || !fault.what_)
+      return false;
+    rules_[rules_n_++] = t_rule_{fault.id_, fault.what_, get(fault.file_),
+                                 fault.line_, fault.tag_, fault.per_million_,
+                                 fault.every_};
+    return true;
+  }
+
+  t_void clear_faults() {
+    rules_n_ = 0;
+    generation_.fetch_add(1, std::memory_order_release); // reset the hits
+  }
+
+  t_void seed_faults(t_seed seed) {
+    seed_.store(seed, std::memory_order_relaxed);
+    ordinal_.store(0, std::memory_order_relaxed);
+    generation_.fetch_add(1, std::memory_order_release);
+  }
+
+  t_void seed_thread_faults(t_seed stream) {
+    thread_.bound_  = true;
+    thread_.stream_ = stream;
+    reseed_(thread_, generation_.load(std::memory_order_acquire));
+  }
+
+  t_void enable_faults(t_bool on) {
+    faults_enabled_.store(on, std::memory_order_release);
+  }
+
+  t_id check_fault(p_what what, P_filename filename, t_lineno line,
+                   t_tagid tag) {
+    const char* file = get(filename);
+    t_id fault = 0;
+    for (t_uint32 ix = 0; ix < rules_n_; ++ix) {
+      const t_rule_& rule = rules_[ix];
+      if (rule.what_ != what || (rule.line_ && rule.line_ != line) ||
+          (rule.tag_ && rule.tag_ != tag) || !match_file_(rule.file_, file))
+        continue;
+      t_thread_& thread = get_thread_();
+      t_bool fire = false;
+      if (rule.every_) {
+        if (++thread.hits_[ix] == rule.every_) {
+          thread.hits_[ix] = 0;
+          fire = true;
+        }
+      } else
+        fire = next_(thread) % 1000000 < rule.per_million_;
+      if (fire && !fault)
+        fault = rule.id_;
+    }
+    return fault;
+  }
+}
+}
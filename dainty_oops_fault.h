@@ -0,0 +1,117 @@
+/******************************************************************************
+
+ MIT License
+
+ Copyright (c) 2018 kieme, frits.germs@gmx.net
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+******************************************************************************/
+
+#ifndef _DAINTY_OOPS_FAULT_H_
+#define _DAINTY_OOPS_FAULT_H_
+
+// fault injection: publish configured errors at mark_block sites.
+//
+//   compiled in with DAINTY_OOPS_FAULT. every mark_block (and therefore
+//   every DAINTY_OOPS_BLOCK_GUARD) asks the fault engine if an error must be
+//   published at that site before the block is executed. when the engine is
+//   disabled this costs one load and one branch.
+//
+//   a rule matches on the domain (p_what), file, line and tag. the domain is
+//   required, so an id is never published in a domain that does not define
+//   it. a zero/null file, line or tag matches anything. a matching rule
+//   fires either every n-th hit of the thread (every_, the hits are counted
+//   per thread, not per process) or with a probability of per_million_ /
+//   1000000. every matching rule counts the hit, also when another rule
+//   fires first, so the rate of a rule does not depend on rule order.
+//
+//   the random numbers come from a per thread generator, seeded from
+//   seed_faults() and the stream of the thread. a thread binds its stream
+//   with seed_thread_faults(), e.g. with its worker index: a run with the
+//   same seed is reproducible per bound stream, whatever the scheduling.
+//   a thread that binds no stream gets one in the order in which threads
+//   first hit a rule, which is not reproducible across threads.
+//
+//   example: 1% of the operations fail with id 7 at the tagged site 3.
+//
+//     add_fault(t_fault{7, what, P_filename{nullptr}, 0, 3, 10000});
+//     seed_faults(42);
+//     enable_faults(true);
+//
+//     worker n:  seed_thread_faults(n);
+
+#include <atomic>
+#include "dainty_oops_ctxt.h"
+
+namespace dainty
+{
+namespace oops
+{
+////////////////////////////////////////////////////////////////////////////////
+
+  using t_per_million = named::t_uint32;
+  using t_every       = named::t_uint32;
+  using t_seed        = named::t_uint64;
+
+  enum { MAX_FAULTS = 16 };
+
+  struct t_fault {
+    t_fault(t_id id, p_what what, P_filename file, t_lineno line,
+            t_tagid tag, t_per_million per_million, t_every every = 0)
+      : id_(id), what_(what), file_(file), line_(line), tag_(tag),
+        per_million_(per_million), every_(every)
+    { }
+
+    t_id          id_;
+    p_what        what_;
+    P_filename    file_;
+    t_lineno      line_;
+    t_tagid       tag_;
+    t_per_million per_million_;
+    t_every       every_;
+  };
+
+  using R_fault = named::t_prefix<t_fault>::R_;
+
+////////////////////////////////////////////////////////////////////////////////
+
+  t_bool add_fault    (R_fault);  // not thread safe, use when disabled
+  t_void clear_faults ();         // not thread safe, use when disabled
+  t_void seed_faults  (t_seed);
+  t_void seed_thread_faults(t_seed stream); // for the calling thread
+  t_void enable_faults(t_bool);
+
+  t_id   check_fault  (p_what, P_filename, t_lineno, t_tagid);
+
+  extern std::atomic<t_bool> faults_enabled_;
+
+////////////////////////////////////////////////////////////////////////////////
+
+  inline
+  t_id inject_fault(p_what what, P_filename file, t_lineno line,
+                    t_tagid tag) {
+    if (faults_enabled_.load(std::memory_order_acquire))
+      return check_fault(what, file, line, tag);
+    return 0;
+  }
+}
+}
+
+#endif
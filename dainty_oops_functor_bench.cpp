@@ -0,0 +1,124 @@
+/******************************************************************************
+
+ MIT License
+
+ Copyright (c) 2018 kieme, frits.germs@gmx.net
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+******************************************************************************/
+
+// usage: dainty_oops_functor_bench [rounds]
+//
+//   the cost of the policy dispatch on publish, per context type. every
+//   round publishes an error and clears it, the policy counts the calls.
+//
+//     fn:       t_ctxt<count>, the function is a template argument.
+//     empty:    t_functor_ctxt with an empty functor.
+//     state:    t_functor_ctxt with a functor that keeps the count.
+//     pointer:  t_functor_ctxt<p_policy, p_print>, the functions are passed
+//               at run time and called through the pointers.
+
+#include <chrono>
+#include <cstdlib>
+#include "dainty_named_terminal.h"
+#include "dainty_oops.h"
+
+using namespace dainty::named::terminal;
+using namespace dainty::oops;
+
+namespace
+{
+  using t_clock = std::chrono::steady_clock;
+  using t_count = unsigned long;
+
+  t_def what(t_id id) {
+    return id ? t_def{IGNORE, P_cstr{"failed"}}
+              : t_def{IGNORE, P_cstr{"bench"}};
+  }
+
+  t_count count_ = 0;
+
+  t_void count(R_info) {
+    ++count_;
+  }
+
+  struct t_empty_policy {
+    t_void operator()(R_info) const { ++count_; }
+  };
+
+  struct t_state_policy {
+    t_void operator()(R_info) { ++n_; }
+    t_count n_ = 0;
+  };
+
+  using t_fn_ctxt      = t_ctxt<count>;
+  using t_empty_ctxt   = t_functor_ctxt<t_empty_policy, t_print_fn<>>;
+  using t_state_ctxt   = t_functor_ctxt<t_state_policy, t_print_fn<>>;
+  using t_pointer_ctxt = t_functor_ctxt<p_policy, p_print>;
+
+  template<class C>
+  t_count calls_(const C&) {
+    return count_;
+  }
+
+  t_count calls_(const t_state_ctxt& ctxt) {
+    return ctxt.get_policy().n_;
+  }
+
+  template<class C>
+  __attribute__((noinline))
+  t_void round_(t_oops<what, t_id, C>& oops) {
+    oops = 1;
+    oops.clear();
+  }
+
+  template<class C>
+  t_void run_(const char* name, C& ctxt, unsigned rounds) {
+    const t_count before = calls_(ctxt);
+    t_oops<what, t_id, C> oops(&ctxt);
+    const auto start = t_clock::now();
+    for (unsigned round = 0; round < rounds; ++round)
+      round_(oops);
+    const std::chrono::duration<double, std::nano> ns =
+      t_clock::now() - start;
+    t_out{FMT, "%-8s %9.2f %10lu\n", name, ns.count() / rounds,
+               calls_(ctxt) - before};
+  }
+}
+
+int main(int argc, char* argv[]) {
+  const unsigned rounds = argc > 1 ? std::atoi(argv[1]) : 10000000;
+
+  t_out{FMT, "rounds = %u\n", rounds};
+  t_out{FMT, "ctxt     ns/round      calls\n"};
+
+  t_fn_ctxt fn;
+  run_("fn", fn, rounds);
+
+  t_empty_ctxt empty;
+  run_("empty", empty, rounds);
+
+  t_state_ctxt state;
+  run_("state", state, rounds);
+
+  t_pointer_ctxt pointer(count, default_print);
+  run_("pointer", pointer, rounds);
+  return 0;
+}
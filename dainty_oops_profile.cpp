@@ -0,0 +1,170 @@
+/******************************************************************************
+
+ MIT License
+
+ Copyright (c) 2018 kieme, frits.germs@gmx.net
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+******************************************************************************/
+
+#include "dainty_named_terminal.h"
+#include "dainty_oops_profile.h"
+
+namespace dainty
+{
+namespace oops
+{
+  using namespace named::terminal;
+  using named::t_uint64;
+
+  std::atomic<t_epoch> profile_epoch_{0};
+
+namespace
+{
+  // written by its own thread only, read by visit_profile().
+  struct t_block_ {
+    std::atomic<const char*> file_{nullptr};
+    std::atomic<t_lineno>    line_{0};
+    std::atomic<t_cycles>    happy_n_{0};
+    std::atomic<t_cycles>    happy_cycles_{0};
+    std::atomic<t_cycles>    error_n_{0};
+    std::atomic<t_cycles>    error_cycles_{0};
+  };
+
+  struct t_table_ {
+    t_thread          thread_ = 0;
+    t_table_*         next_   = nullptr;
+    std::atomic<bool> used_{true};
+    t_block_          block_[PROFILE_BLOCKS];
+  };
+
+  std::atomic<t_table_*> tables_{nullptr};
+  std::atomic<t_thread>  threads_{0};
+
+  // hands the table back when its thread exits.
+  struct t_owner_ {
+    ~t_owner_() {
+      if (table_)
+        table_->used_.store(false, std::memory_order_release);
+    }
+    t_table_* table_ = nullptr;
+  };
+
+  thread_local t_owner_ owner_;
+
+  t_table_* claim_table_() {
+    for (t_table_* table = tables_.load(std::memory_order_acquire); table;
+         table = table->next_) {
+      bool used = false;
+      if (!table->used_.load(std::memory_order_relaxed) &&
+          table->used_.compare_exchange_strong(used, true,
+                                               std::memory_order_acquire))
+        return table;
+    }
+    t_table_* table = new t_table_; // tables are never freed, only reused
+    table->thread_  = threads_.fetch_add(1, std::memory_order_relaxed);
+    table->next_    = tables_.load(std::memory_order_relaxed);
+    while (!tables_.compare_exchange_weak(table->next_, table,
+                                          std::memory_order_release))
+      ;
+    return table;
+  }
+
+  inline t_table_* get_table_() {
+    if (!owner_.table_)
+      owner_.table_ = claim_table_();
+    return owner_.table_;
+  }
+
+  inline t_void add_(std::atomic<t_cycles>& value, t_cycles n) {
+    value.store(value.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+  }
+
+  inline t_uint64 hash_(const char* file, t_lineno line) {
+    return ((reinterpret_cast<t_uint64>(file) >> 3) ^ line) *
+           0x9e3779b97f4a7c15ULL;
+  }
+}
+
+  t_void enable_profile(t_bool on) {
+    t_epoch epoch = profile_epoch_.load(std::memory_order_relaxed);
+    while (static_cast<t_bool>(epoch & 1) != on &&
+           !profile_epoch_.compare_exchange_weak(epoch, epoch + 1,
+                                                 std::memory_order_release))
+      ;
+  }
+
+  t_void add_profile(P_filename filename, t_lineno line, t_cycles cycles,
+                     t_bool error) {
+    const char* file = get(filename);
+    t_table_* table  = get_table_();
+    t_uint64 ix = hash_(file, line) >> 32;
+    for (t_uint64 n = 0; n < PROFILE_BLOCKS; ++n, ++ix) {
+      t_block_& block = table->block_[ix % PROFILE_BLOCKS];
+      const char* block_file = block.file_.load(std::memory_order_relaxed);
+      if (!block_file) {
+        block.line_.store(line, std::memory_order_relaxed);
+        block.file_.store(file, std::memory_order_release);
+      } else if (block_file != file ||
+                 block.line_.load(std::memory_order_relaxed) != line)
+        continue;
+      if (error) {
+        add_(block.error_n_, 1);
+        add_(block.error_cycles_, cycles);
+      } else {
+        add_(block.happy_n_, 1);
+        add_(block.happy_cycles_, cycles);
+      }
+      return;
+    }
+    // table full: the interval is not attributed
+  }
+
+  t_void visit_profile(p_profile_visit visit) {
+    for (t_table_* table = tables_.load(std::memory_order_acquire); table;
+         table = table->next_) {
+      for (auto& block : table->block_) {
+        const char* file = block.file_.load(std::memory_order_acquire);
+        if (file)
+          visit(t_profile_entry{
+            table->thread_, P_filename{file},
+            block.line_        .load(std::memory_order_relaxed),
+            block.happy_n_     .load(std::memory_order_relaxed),
+            block.happy_cycles_.load(std::memory_order_relaxed),
+            block.error_n_     .load(std::memory_order_relaxed),
+            block.error_cycles_.load(std::memory_order_relaxed)});
+      }
+    }
+  }
+
+  t_void print_profile() {
+    visit_profile([](R_profile_entry entry) {
+      t_out{FMT, "profile[thread-%u] %s:%d, happy = %llu/%llu, "
+                 "error = %llu/%llu (n/cycles)\n", entry.thread_,
+                 get(entry.file_), entry.line_,
+                 static_cast<unsigned long long>(entry.happy_n_),
+                 static_cast<unsigned long long>(entry.happy_cycles_),
+                 static_cast<unsigned long long>(entry.error_n_),
+                 static_cast<unsigned long long>(entry.error_cycles_)};
+    });
+  }
+}
+}
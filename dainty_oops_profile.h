@@ -0,0 +1,139 @@
+/******************************************************************************
+
+ MIT License
+
+ Copyright (c) 2018 kieme, frits.germs@gmx.net
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+******************************************************************************/
+
+#ifndef _DAINTY_OOPS_PROFILE_H_
+#define _DAINTY_OOPS_PROFILE_H_
+
+// block profiler: mark_block as probe points.
+//
+//   compiled in with DAINTY_OOPS_PROFILE and switched on with
+//   enable_profile(). a t_oops timestamps every mark_block and its
+//   destruction (step_out). the cycles between two probes are attributed to
+//   the (file, line) of the first, as happy path time when no error is set
+//   at the second probe and as error path time otherwise.
+//
+//   every thread aggregates into its own table, so probes need no locks.
+//   the table of a thread that is gone stays for export and is handed to
+//   the next new thread, which adds to its counts: the number of tables is
+//   the largest number of threads that probed at the same time.
+//   visit_profile() or print_profile() export all of them.
+//
+//   every enable_profile() starts a new epoch. a probe taken in an earlier
+//   epoch is not charged, so the time while switched off is never counted.
+//   when switched off a probe costs one relaxed load and a branch.
+
+#include <atomic>
+#include "dainty_oops_ctxt.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace dainty
+{
+namespace oops
+{
+////////////////////////////////////////////////////////////////////////////////
+
+  using t_cycles = named::t_uint64;
+  using t_thread = named::t_uint32;
+  using t_epoch  = named::t_uint32;
+
+  enum { PROFILE_BLOCKS = 512 };
+
+  struct t_probe {
+    t_probe() : file_(nullptr), line_(0), stamp_(0), epoch_(0) { }
+
+    P_filename file_;
+    t_lineno   line_;
+    t_cycles   stamp_;
+    t_epoch    epoch_;
+  };
+
+  struct t_profile_entry {
+    t_thread   thread_;
+    P_filename file_;
+    t_lineno   line_;
+    t_cycles   happy_n_;
+    t_cycles   happy_cycles_;
+    t_cycles   error_n_;
+    t_cycles   error_cycles_;
+  };
+
+  using r_probe         = named::t_prefix<t_probe>::r_;
+  using R_profile_entry = named::t_prefix<t_profile_entry>::R_;
+
+  typedef t_void (*p_profile_visit)(R_profile_entry);
+
+////////////////////////////////////////////////////////////////////////////////
+
+  t_void enable_profile(t_bool);
+  t_void add_profile   (P_filename, t_lineno, t_cycles, t_bool error);
+  t_void visit_profile (p_profile_visit);
+  t_void print_profile ();
+
+  // odd when switched on, incremented by every switch.
+  extern std::atomic<t_epoch> profile_epoch_;
+
+////////////////////////////////////////////////////////////////////////////////
+
+  inline
+  t_cycles profile_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+  }
+
+  inline
+  t_void probe_block(r_probe probe, P_filename file, t_lineno line,
+                     t_bool error) {
+    const t_epoch epoch = profile_epoch_.load(std::memory_order_relaxed);
+    if (epoch & 1) {
+      const t_cycles now = profile_cycles();
+      if (get(probe.file_) && probe.epoch_ == epoch)
+        add_profile(probe.file_, probe.line_, now - probe.stamp_, error);
+      probe.file_  = file;
+      probe.line_  = line;
+      probe.stamp_ = now;
+      probe.epoch_ = epoch;
+    }
+  }
+
+  inline
+  t_void probe_out(r_probe probe, t_bool error) {
+    if (get(probe.file_) &&
+        probe.epoch_ == profile_epoch_.load(std::memory_order_relaxed))
+      add_profile(probe.file_, probe.line_, profile_cycles() - probe.stamp_,
+                  error);
+  }
+}
+}
+
+#endif
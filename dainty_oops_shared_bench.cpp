@@ -0,0 +1,153 @@
+/******************************************************************************
+
+ MIT License
+
+ Copyright (c) 2018 kieme, frits.germs@gmx.net
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+******************************************************************************/
+
+// usage: dainty_oops_shared_bench [items] [max-threads]
+//
+//   scaling of a parallel loop on a t_shared_ctxt, 1 .. max-threads (64).
+//   the items are handed out in chunks. every item polls the worker t_oops
+//   (a relaxed load) before it runs.
+//
+//     plain:  the loop without t_oops, the baseline.
+//     poll:   the loop with polling, no error.
+//     cancel: item items/10 publishes an error, the others stop early.
+//             "after" counts the items that still ran after the publish.
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "dainty_named_terminal.h"
+#include "dainty_oops.h"
+#include "dainty_oops_shared_ctxt.h"
+
+using namespace dainty::named::terminal;
+using namespace dainty::oops;
+
+namespace
+{
+  using t_clock  = std::chrono::steady_clock;
+  using t_item   = unsigned long;
+
+  enum { CHUNK = 1024 };
+
+  t_def what(t_id id) {
+    return id ? t_def{IGNORE, P_cstr{"cancelled"}}
+              : t_def{IGNORE, P_cstr{"bench"}};
+  }
+
+  using t_bench_oops = t_oops<what, t_id, t_shared_ctxt<>>;
+
+  inline t_item work_(t_item item) {
+    t_item x = item * 0x9e3779b97f4a7c15UL;
+    for (int n = 0; n < 64; ++n)
+      x ^= (x << 7) ^ (x >> 9);
+    return x;
+  }
+
+  struct t_result {
+    double ms_;
+    t_item ran_;
+    t_item after_;
+  };
+
+  template<class F>
+  t_result run_(int threads, t_item items, F body) {
+    std::atomic<t_item> next{0}, ran{0}, after{0};
+    std::atomic<t_bool> published{false};
+    std::vector<std::thread> pool;
+    const auto start = t_clock::now();
+    for (int t = 0; t < threads; ++t)
+      pool.emplace_back([&] {
+        t_item local = 0, late = 0, sink = 0;
+        body(next, items, local, late, sink, published);
+        ran   += local;
+        after += late;
+        if (sink == 42) // keep the work
+          t_out{FMT, "."};
+      });
+    for (auto& thread : pool)
+      thread.join();
+    const std::chrono::duration<double, std::milli> ms =
+      t_clock::now() - start;
+    return t_result{ms.count(), ran.load(), after.load()};
+  }
+}
+
+int main(int argc, char* argv[]) {
+  const t_item items = argc > 1 ? std::atol(argv[1]) : 1UL << 22;
+  const int    max   = argc > 2 ? std::atoi(argv[2]) : 64;
+
+  t_out{FMT, "items = %lu, chunk = %d\n", items, CHUNK};
+  t_out{FMT, "threads     plain ms   poll ms  cancel ms  cancel ran   after\n"};
+  for (int threads = 1; threads <= max; threads *= 2) {
+    auto plain = run_(threads, items,
+      [](std::atomic<t_item>& next, t_item n, t_item& ran, t_item&,
+         t_item& sink, std::atomic<t_bool>&) {
+        for (t_item begin; (begin = next.fetch_add(CHUNK)) < n; )
+          for (t_item i = begin; i < begin + CHUNK && i < n; ++i, ++ran)
+            sink += work_(i);
+      });
+
+    t_shared_ctxt<> poll_ctxt;
+    t_bench_oops poll_owner(&poll_ctxt);
+    auto poll = run_(threads, items,
+      [&](std::atomic<t_item>& next, t_item n, t_item& ran, t_item&,
+          t_item& sink, std::atomic<t_bool>&) {
+        t_bench_oops worker(poll_owner);
+        for (t_item begin; !worker && (begin = next.fetch_add(CHUNK)) < n; )
+          for (t_item i = begin; i < begin + CHUNK && i < n && !worker;
+               ++i, ++ran)
+            sink += work_(i);
+      });
+
+    t_shared_ctxt<> cancel_ctxt;
+    t_bench_oops cancel_owner(&cancel_ctxt);
+    const t_item fail = items / 10;
+    auto cancel = run_(threads, items,
+      [&](std::atomic<t_item>& next, t_item n, t_item& ran, t_item& late,
+          t_item& sink, std::atomic<t_bool>& published) {
+        t_bench_oops worker(cancel_owner);
+        for (t_item begin; !worker && (begin = next.fetch_add(CHUNK)) < n; )
+          for (t_item i = begin; i < begin + CHUNK && i < n && !worker;
+               ++i, ++ran) {
+            if (published.load(std::memory_order_relaxed))
+              ++late;
+            sink += work_(i);
+            if (i == fail) {
+              worker = 1;
+              published.store(true, std::memory_order_relaxed);
+            }
+          }
+      });
+    if (cancel_owner)
+      cancel_owner.clear();
+
+    t_out{FMT, "%7d  %9.2f %9.2f  %9.2f  %10lu  %6lu\n", threads, plain.ms_,
+               poll.ms_, cancel.ms_, cancel.ran_, cancel.after_};
+  }
+  return 0;
+}
@@ -0,0 +1,235 @@
+/******************************************************************************
+
+ MIT License
+
+ Copyright (c) 2018 kieme, frits.germs@gmx.net
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+******************************************************************************/
+
+#ifndef _DAINTY_OOPS_SHARED_CTXT_H_
+#define _DAINTY_OOPS_SHARED_CTXT_H_
+
+// t_shared_ctxt: a context that one owner shares with parallel workers.
+//
+//   fan-out: the owner creates the context and each worker uses its own
+//   t_oops copy of the owner. the first publish wins, later publishes are
+//   counted (get_dropped) and dropped. workers can poll their t_oops
+//   (operator t_bool) which is a relaxed load, to abandon work early.
+//
+//   fan-in: after the workers are joined, the owner inspects and clears
+//   the error as usual. clear() must not race with workers.
+//
+//   the workers do not share one call chain, so no breadcrumbs are kept.
+//
+//     using t_shared_oops = oops::t_oops<what, t_id, oops::t_shared_ctxt<>>;
+//
+//     t_shared_oops oops;
+//     parallel_for(n, [&](int i) {
+//       t_shared_oops worker(oops);
+//       if (!worker)
+//         do_work(i, worker);
+//     });
+//     if (oops)
+//       handle(oops.clear());
+
+#include <atomic>
+#include "dainty_oops_ctxt.h"
+
+namespace dainty
+{
+namespace oops
+{
+////////////////////////////////////////////////////////////////////////////////
+
+  using t_dropped = named::t_uint32;
+
+  template<p_policy A = default_policy, p_print P = default_print>
+  class t_shared_ctxt {
+  public:
+    t_shared_ctxt();
+
+    t_bool set(t_id, p_what, R_data1);
+    t_bool set(t_id, p_what, R_data2);
+    t_bool set(R_info);
+
+    t_id      get_id     () const;
+    t_depth   get_depth  () const;
+    p_what    get_what   () const;
+    t_info    get_info   () const;
+    t_dropped get_dropped() const;
+
+    t_info clear();
+
+    void print(R_data) const;
+    P_cstr what() const;
+
+    void step_in (R_data, p_what);
+    void step_out(R_data, p_what);
+    void step_do (R_data, p_what);
+
+#ifdef DAINTY_OOPS_BREADCRUMB
+    void crumb  (P_filename, t_lineno, t_depth) { }
+    void uncrumb(t_depth)                       { }
+#endif
+
+  private:
+    t_bool claim_();
+
+    std::atomic<t_bool>    claimed_;
+    std::atomic<t_id>      id_;
+    std::atomic<t_dropped> dropped_;
+    t_info                 info_;
+  };
+
+  template<p_policy A, p_print P>
+  struct t_ctxt_shared<t_shared_ctxt<A, P>> {
+    enum { VALUE = true };
+  };
+
+////////////////////////////////////////////////////////////////////////////////
+
+  template<p_policy A, p_print P>
+  inline
+  t_shared_ctxt<A, P>::t_shared_ctxt()
+    : claimed_(false), id_(0), dropped_(0), info_(this) {
+  }
+
+  template<p_policy A, p_print P>
+  inline
+  t_bool t_shared_ctxt<A, P>::claim_() {
+    t_bool expected = false;
+    if (!id_.load(std::memory_order_relaxed) &&
+        claimed_.compare_exchange_strong(expected, true,
+                                         std::memory_order_acquire))
+      return true;
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  template<p_policy A, p_print P>
+  inline
+  t_bool t_shared_ctxt<A, P>::set(t_id id, p_what what, R_data1 data) {
+    if (!claim_())
+      return false;
+    info_.set(id, what, 0, data.tag_, P_cstr{nullptr}, 0);
+    id_.store(id, std::memory_order_release);
+    A(info_);
+    return true;
+  }
+
+  template<p_policy A, p_print P>
+  inline
+  t_bool t_shared_ctxt<A, P>::set(t_id id, p_what what, R_data2 data) {
+    if (!claim_())
+      return false;
+    info_.set(id, what, data.depth_, data.tag_, data.file_, data.line_);
+    id_.store(id, std::memory_order_release);
+    A(info_);
+    return true;
+  }
+
+  template<p_policy A, p_print P>
+  inline
+  t_bool t_shared_ctxt<A, P>::set(R_info info) {
+    if (!claim_())
+      return false;
+    info_ = info;
+    id_.store(info.id_, std::memory_order_release);
+    A(info_);
+    return true;
+  }
+
+  template<p_policy A, p_print P>
+  inline
+  t_id t_shared_ctxt<A, P>::get_id() const {
+    return id_.load(std::memory_order_relaxed);
+  }
+
+  template<p_policy A, p_print P>
+  inline
+  t_depth t_shared_ctxt<A, P>::get_depth() const {
+    return id_.load(std::memory_order_acquire) ? info_.depth_ : 0;
+  }
+
+  template<p_policy A, p_print P>
+  inline
+  p_what t_shared_ctxt<A, P>::get_what() const {
+    return id_.load(std::memory_order_acquire) ? info_.what_ : nullptr;
+  }
+
+  template<p_policy A, p_print P>
+  inline
+  t_info t_shared_ctxt<A, P>::get_info() const {
+    if (id_.load(std::memory_order_acquire))
+      return info_;
+    return t_info(this);
+  }
+
+  template<p_policy A, p_print P>
+  inline
+  t_dropped t_shared_ctxt<A, P>::get_dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  template<p_policy A, p_print P>
+  inline
+  t_void t_shared_ctxt<A, P>::print(R_data data) const {
+    P(get_info(), data);
+  }
+
+  template<p_policy A, p_print P>
+  inline
+  P_cstr t_shared_ctxt<A, P>::what() const {
+    const t_info info = get_info();
+    return info.what_ ? info.what_(info.id_).string_ : P_cstr{"no oops"};
+  }
+
+  template<p_policy A, p_print P>
+  inline
+  t_info t_shared_ctxt<A, P>::clear() {
+    t_info tmp = get_info();
+    info_.reset();
+    id_.store(0, std::memory_order_relaxed);
+    claimed_.store(false, std::memory_order_release);
+    return tmp;
+  }
+
+  template<p_policy A, p_print P>
+  inline
+  t_void t_shared_ctxt<A, P>::step_in(R_data data, p_what what) {
+    trace_step_in(get_info(), what, this, data);
+  }
+
+  template<p_policy A, p_print P>
+  inline
+  t_void t_shared_ctxt<A, P>::step_out(R_data data, p_what what) {
+    trace_step_out(get_info(), what, this, data);
+  }
+
+  template<p_policy A, p_print P>
+  inline
+  t_void t_shared_ctxt<A, P>::step_do(R_data data, p_what what) {
+    trace_step_do(get_info(), what, this, data);
+  }
+}
+}
+
+#endif
@@ -0,0 +1,133 @@
+/******************************************************************************
+
+ MIT License
+
+ Copyright (c) 2018 kieme, frits.germs@gmx.net
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+******************************************************************************/
+
+// usage: dainty_oops_slim_bench [depth] [rounds]
+//
+//   a recursion of depth frames that passes the error handle down, with
+//   t_oops (by reference, a new frame per level) and t_slim_oops (by value,
+//   deeper() per level).
+//   the deepest frame publishes every 8th round, the callers test and clear.
+//
+//     ns/frame:    time per recursion level.
+//     stack/frame: bytes of stack per level, from the addresses of a local
+//                  in two consecutive levels.
+
+#include <chrono>
+#include <cstdlib>
+#include "dainty_named_terminal.h"
+#include "dainty_oops.h"
+
+using namespace dainty::named::terminal;
+using namespace dainty::oops;
+
+namespace
+{
+  using t_clock = std::chrono::steady_clock;
+
+  t_def what(t_id id) {
+    return id ? t_def{IGNORE, P_cstr{"failed"}}
+              : t_def{IGNORE, P_cstr{"bench"}};
+  }
+
+  using t_bench_oops = t_oops<what>;
+  using t_bench_slim = t_slim_oops<what>;
+
+  unsigned long top_   = 0;
+  unsigned long below_ = 0;
+
+  void mark_(unsigned level) {
+    char local;
+    if (level == 1)
+      top_ = reinterpret_cast<unsigned long>(&local);
+    else if (level == 2)
+      below_ = reinterpret_cast<unsigned long>(&local);
+  }
+
+  __attribute__((noinline))
+  unsigned deep_oops(const t_bench_oops& parent, unsigned level,
+                     t_bool fail) {
+    t_bench_oops oops(parent);
+    mark_(level);
+    if (DAINTY_OOPS_BLOCK_GUARD(oops)) {
+      if (level > 1)
+        return deep_oops(oops, level - 1, fail) + 1;
+      if (fail)
+        oops = 1;
+    }
+    return 1;
+  }
+
+  __attribute__((noinline))
+  unsigned deep_slim(t_bench_slim oops, unsigned level, t_bool fail) {
+    mark_(level);
+    if (DAINTY_OOPS_BLOCK_GUARD(oops)) {
+      if (level > 1)
+        return deep_slim(oops.deeper(), level - 1, fail) + 1;
+      if (fail)
+        oops = 1;
+    }
+    return 1;
+  }
+
+  template<class F>
+  void run_(const char* name, unsigned depth, unsigned rounds, F body) {
+    top_ = below_ = 0;
+    unsigned sink = 0;
+    const auto start = t_clock::now();
+    for (unsigned round = 0; round < rounds; ++round)
+      sink += body(depth, (round & 7) == 0);
+    const std::chrono::duration<double, std::nano> ns =
+      t_clock::now() - start;
+    t_out{FMT, "%-6s %10.2f %12ld %8u\n", name,
+               ns.count() / (static_cast<double>(depth) * rounds),
+               below_ && top_ ? static_cast<long>(below_ - top_) : 0L,
+               sink / rounds};
+  }
+}
+
+int main(int argc, char* argv[]) {
+  const unsigned depth  = argc > 1 ? std::atoi(argv[1]) : 1000;
+  const unsigned rounds = argc > 2 ? std::atoi(argv[2]) : 10000;
+
+  t_out{FMT, "depth = %u, rounds = %u\n", depth, rounds};
+  t_out{FMT, "handle   ns/frame  stack/frame   levels\n"};
+
+  t_bench_oops root;
+  run_("t_oops", depth, rounds, [&](unsigned n, t_bool fail) {
+    const unsigned levels = deep_oops(root, n, fail);
+    if (root)
+      root.clear();
+    return levels;
+  });
+  run_("slim", depth, rounds, [&](unsigned n, t_bool fail) {
+    t_bench_slim slim(root);
+    const unsigned levels = deep_slim(slim, n, fail);
+    if (slim)
+      slim.clear();
+    return levels;
+  });
+  return 0;
+}
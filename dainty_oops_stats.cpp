@@ -0,0 +1,197 @@
+/******************************************************************************
+
+ MIT License
+
+ Copyright (c) 2018 kieme, frits.germs@gmx.net
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+******************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "dainty_oops_stats.h"
+
+namespace dainty
+{
+namespace oops
+{
+  std::atomic<p_stats_region> stats_region_{nullptr};
+
+namespace
+{
+  using t_slot_ = t_stats_slot;
+
+  inline t_uint64 key_(p_what what) {
+    return reinterpret_cast<t_uint64>(what);
+  }
+
+  inline t_uint32 hash_(t_uint64 key, t_id id) {
+    t_uint64 x = (key ^ (static_cast<t_uint64>(id) << 32 | id)) *
+                 0x9e3779b97f4a7c15ULL;
+    return static_cast<t_uint32>(x >> 32) % STATS_SLOTS;
+  }
+
+  inline t_void copy_name_(char* dst, P_cstr src) {
+    const char* str = get(src);
+    if (str) {
+      std::strncpy(dst, str, STATS_NAME_MAX - 1);
+      dst[STATS_NAME_MAX - 1] = '\0';
+    }
+  }
+
+  t_slot_* find_(p_stats_region region, R_info info) {
+    const t_uint64 key = key_(info.what_);
+    t_uint32 ix = hash_(key, info.id_);
+    for (t_uint32 n = 0; n < STATS_SLOTS; ++n, ix = (ix + 1) % STATS_SLOTS) {
+      t_slot_& slot = region->slot_[ix];
+      t_uint32 state = slot.state_.load(std::memory_order_acquire);
+      if (state == STATS_FREE &&
+          slot.state_.compare_exchange_strong(state, STATS_CLAIMING,
+                                              std::memory_order_acquire)) {
+        slot.domain_key_ = key;
+        slot.id_         = info.id_;
+        copy_name_(slot.domain_, info.what_(0).string_);
+        copy_name_(slot.what_,   info.what_(info.id_).string_);
+        slot.state_.store(STATS_READY, std::memory_order_release);
+        return &slot;
+      }
+      while (state == STATS_CLAIMING)
+        state = slot.state_.load(std::memory_order_acquire);
+      if (slot.domain_key_ == key && slot.id_ == info.id_)
+        return &slot;
+    }
+    return nullptr; // full: the error is not counted
+  }
+
+  inline t_uint32 lock_(t_slot_& slot) {
+    t_uint32 seq = slot.seq_.load(std::memory_order_relaxed);
+    for (;;) {
+      if (!(seq & 1) &&
+          slot.seq_.compare_exchange_weak(seq, seq + 1,
+                                          std::memory_order_acquire))
+        break;
+      seq = slot.seq_.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    return seq + 2;
+  }
+
+  inline t_void unlock_(t_slot_& slot, t_uint32 seq) {
+    slot.seq_.store(seq, std::memory_order_release);
+  }
+
+  template<typename T>
+  inline t_void add_(std::atomic<T>& value, T n) {
+    value.store(value.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+  }
+}
+
+  t_bool open_stats(P_cstr path) {
+    if (stats_region_.load())
+      return false;
+    char tmp[4096];
+    if (std::snprintf(tmp, sizeof(tmp), "%s.%d", get(path),
+                      static_cast<int>(::getpid())) >= int(sizeof(tmp)))
+      return false;
+    const int fd = ::open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      return false;
+    void* addr = MAP_FAILED;
+    if (!::ftruncate(fd, sizeof(t_stats_region)))
+      addr = ::mmap(nullptr, sizeof(t_stats_region), PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+      ::unlink(tmp);
+      return false;
+    }
+
+    p_stats_region region = static_cast<p_stats_region>(addr);
+    region->version_   = STATS_VERSION;
+    region->slots_     = STATS_SLOTS;
+    region->slot_size_ = sizeof(t_stats_slot);
+    region->pid_       = static_cast<t_uint64>(::getpid());
+    region->magic_.store(STATS_MAGIC, std::memory_order_release);
+    if (::rename(tmp, get(path))) {
+      ::munmap(addr, sizeof(t_stats_region));
+      ::unlink(tmp);
+      return false;
+    }
+    stats_region_.store(region, std::memory_order_release);
+    return true;
+  }
+
+  t_void close_stats() {
+    // not unmapped: a thread can be between loading stats_region_ and
+    // writing to it. the mapping goes away when the process exits.
+    stats_region_.store(nullptr, std::memory_order_release);
+  }
+
+  t_void update_stats_publish(R_info info) {
+    p_stats_region region = stats_region_.load(std::memory_order_acquire);
+    t_slot_* slot = region ? find_(region, info) : nullptr;
+    if (slot) {
+      const t_uint32 seq = lock_(*slot);
+      add_(slot->published_, t_uint64{1});
+      add_(slot->active_,    t_uint64{1});
+      slot->last_tag_  .store(info.tag_,   std::memory_order_relaxed);
+      slot->last_depth_.store(info.depth_, std::memory_order_relaxed);
+      slot->last_line_ .store(info.line_,  std::memory_order_relaxed);
+      unlock_(*slot, seq);
+    }
+  }
+
+  t_void update_stats_clear(R_info info) {
+    p_stats_region region = stats_region_.load(std::memory_order_acquire);
+    t_slot_* slot = region ? find_(region, info) : nullptr;
+    if (slot) {
+      const t_uint32 seq = lock_(*slot);
+      add_(slot->cleared_, t_uint64{1});
+      if (slot->active_.load(std::memory_order_relaxed))
+        add_(slot->active_, ~t_uint64{0});
+      unlock_(*slot, seq);
+    }
+  }
+
+  t_stats_read read_stats_slot(R_stats_slot slot, r_stats_values values) {
+    if (slot.state_.load(std::memory_order_acquire) != STATS_READY)
+      return STATS_UNUSED;
+    for (t_uint32 n = 0; n < STATS_RETRIES; ++n) {
+      const t_uint32 seq = slot.seq_.load(std::memory_order_acquire);
+      if (seq & 1)
+        continue;
+      values.published_  = slot.published_ .load(std::memory_order_relaxed);
+      values.cleared_    = slot.cleared_   .load(std::memory_order_relaxed);
+      values.active_     = slot.active_    .load(std::memory_order_relaxed);
+      values.last_tag_   = slot.last_tag_  .load(std::memory_order_relaxed);
+      values.last_depth_ = slot.last_depth_.load(std::memory_order_relaxed);
+      values.last_line_  = slot.last_line_ .load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.seq_.load(std::memory_order_relaxed) == seq)
+        return STATS_OK;
+    }
+    return STATS_BUSY;
+  }
+}
+}
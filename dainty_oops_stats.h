@@ -0,0 +1,150 @@
+/******************************************************************************
+
+ MIT License
+
+ Copyright (c) 2018 kieme, frits.germs@gmx.net
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+******************************************************************************/
+
+#ifndef _DAINTY_OOPS_STATS_H_
+#define _DAINTY_OOPS_STATS_H_
+
+// statistics export: per domain, per id counters in a memory mapped file.
+//
+//   compiled in with DAINTY_OOPS_STATS and switched on with open_stats().
+//   every publish and clear of a t_oops updates the slot of its (domain, id).
+//   the domain name is what(0).string_ and the id name is what(id).string_.
+//
+//   the file is a t_stats_region. a slot is claimed once (state_) and
+//   thereafter its values are written under a seqlock (seq_), so a reader in
+//   another process can take consistent snapshots with read_stats_slot()
+//   without locking the writer. writers do not make system calls.
+//
+//   open_stats() sizes and initializes the region in a temporary file and
+//   renames it over the path, so a reader never maps a short file.
+//   close_stats() stops the updates but keeps the mapping until the process
+//   exits, because other threads may still be writing into it.
+//
+//   counters: published_, cleared_
+//   gauges:   active_ (published but not yet cleared), last tag/depth/line.
+//
+//   see dainty_oops_stats_reader.cpp for a polling reader.
+
+#include <atomic>
+#include "dainty_oops_ctxt.h"
+
+namespace dainty
+{
+namespace oops
+{
+////////////////////////////////////////////////////////////////////////////////
+
+  using named::t_uint32;
+  using named::t_uint64;
+
+  enum {
+    STATS_MAGIC    = 0x4f4f5053, // "OOPS"
+    STATS_VERSION  = 1,
+    STATS_SLOTS    = 1024,
+    STATS_NAME_MAX = 32,
+    STATS_RETRIES  = 1024
+  };
+
+  enum t_stats_read {
+    STATS_UNUSED = 0,
+    STATS_OK     = 1,
+    STATS_BUSY   = 2  // no snapshot within STATS_RETRIES, writer may be dead
+  };
+
+  enum t_stats_state : t_uint32 {
+    STATS_FREE     = 0,
+    STATS_CLAIMING = 1,
+    STATS_READY    = 2
+  };
+
+  struct t_stats_slot {
+    std::atomic<t_uint32> seq_;
+    std::atomic<t_uint32> state_;
+    t_uint64              domain_key_;
+    t_id                  id_;
+    char                  domain_[STATS_NAME_MAX];
+    char                  what_  [STATS_NAME_MAX];
+    std::atomic<t_uint64> published_;
+    std::atomic<t_uint64> cleared_;
+    std::atomic<t_uint64> active_;
+    std::atomic<t_uint32> last_tag_;
+    std::atomic<t_uint32> last_depth_;
+    std::atomic<t_uint32> last_line_;
+  };
+
+  struct t_stats_region {
+    std::atomic<t_uint32> magic_;
+    t_uint32              version_;
+    t_uint32              slots_;
+    t_uint32              slot_size_;
+    t_uint64              pid_;
+    t_stats_slot          slot_[STATS_SLOTS];
+  };
+
+  struct t_stats_values {
+    t_uint64 published_;
+    t_uint64 cleared_;
+    t_uint64 active_;
+    t_uint32 last_tag_;
+    t_uint32 last_depth_;
+    t_uint32 last_line_;
+  };
+
+  using p_stats_region = named::t_prefix<t_stats_region>::p_;
+  using P_stats_region = named::t_prefix<t_stats_region>::P_;
+  using R_stats_slot   = named::t_prefix<t_stats_slot>::R_;
+  using r_stats_values = named::t_prefix<t_stats_values>::r_;
+
+////////////////////////////////////////////////////////////////////////////////
+
+  t_bool open_stats (P_cstr path);
+  t_void close_stats();
+
+  t_void update_stats_publish(R_info);
+  t_void update_stats_clear  (R_info);
+
+  // reader side: the values are valid with STATS_OK only.
+  t_stats_read read_stats_slot(R_stats_slot, r_stats_values);
+
+  extern std::atomic<p_stats_region> stats_region_;
+
+////////////////////////////////////////////////////////////////////////////////
+
+  inline
+  t_void stats_publish(R_info info) {
+    if (stats_region_.load(std::memory_order_relaxed))
+      update_stats_publish(info);
+  }
+
+  inline
+  t_void stats_clear(R_info info) {
+    if (stats_region_.load(std::memory_order_relaxed))
+      update_stats_clear(info);
+  }
+}
+}
+
+#endif
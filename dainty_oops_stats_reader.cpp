@@ -0,0 +1,104 @@
+/******************************************************************************
+
+ MIT License
+
+ Copyright (c) 2018 kieme, frits.germs@gmx.net
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+******************************************************************************/
+
+// usage: dainty_oops_stats_reader <file> [interval-ms] [count]
+//
+//   polls the statistics file written by open_stats() and prints every slot
+//   in use. with count 0 (default) it polls until killed.
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "dainty_named_terminal.h"
+#include "dainty_oops_stats.h"
+
+using namespace dainty::named::terminal;
+using namespace dainty::oops;
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    t_out{FMT, "usage: %s <file> [interval-ms] [count]\n", argv[0]};
+    return 1;
+  }
+  const long interval = argc > 2 ? std::atol(argv[2]) : 1000;
+  const long count    = argc > 3 ? std::atol(argv[3]) : 0;
+
+  const int fd = ::open(argv[1], O_RDONLY);
+  if (fd < 0) {
+    t_out{FMT, "cannot open %s\n", argv[1]};
+    return 1;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) ||
+      st.st_size < static_cast<off_t>(sizeof(t_stats_region))) {
+    ::close(fd);
+    t_out{FMT, "%s: not a statistics file (yet)\n", argv[1]};
+    return 1;
+  }
+  void* addr = ::mmap(nullptr, sizeof(t_stats_region), PROT_READ, MAP_SHARED,
+                      fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    t_out{FMT, "cannot map %s\n", argv[1]};
+    return 1;
+  }
+
+  P_stats_region region = static_cast<P_stats_region>(addr);
+  if (region->magic_.load(std::memory_order_acquire) != STATS_MAGIC ||
+      region->version_   != STATS_VERSION ||
+      region->slots_     != STATS_SLOTS   ||
+      region->slot_size_ != sizeof(t_stats_slot)) {
+    t_out{FMT, "%s: unknown layout\n", argv[1]};
+    return 1;
+  }
+
+  for (long n = 0; !count || n < count; ++n) {
+    if (n)
+      ::usleep(static_cast<useconds_t>(interval) * 1000);
+    t_out{FMT, "pid %llu, poll %ld\n",
+               static_cast<unsigned long long>(region->pid_), n};
+    for (auto& slot : region->slot_) {
+      t_stats_values values;
+      const t_stats_read read = read_stats_slot(slot, values);
+      if (read == STATS_BUSY)
+        t_out{FMT, "  %s:%u %s, locked\n", slot.domain_, slot.id_,
+                   slot.what_};
+      else if (read == STATS_OK)
+        t_out{FMT, "  %s:%u %s, published = %llu, cleared = %llu, "
+                   "active = %llu, tag-%u, depth-%u, line-%u\n",
+                   slot.domain_, slot.id_, slot.what_,
+                   static_cast<unsigned long long>(values.published_),
+                   static_cast<unsigned long long>(values.cleared_),
+                   static_cast<unsigned long long>(values.active_),
+                   values.last_tag_, values.last_depth_, values.last_line_};
+    }
+  }
+
+  ::munmap(addr, sizeof(t_stats_region));
+  return 0;
+}
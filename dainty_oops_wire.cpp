@@ -0,0 +1,141 @@
+/******************************************************************************
+
+ MIT License
+
+ Copyright (c) 2018 kieme, frits.germs@gmx.net
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+******************************************************************************/
+
+#include <cstring>
+#include "dainty_oops_wire.h"
+
+namespace dainty
+{
+namespace oops
+{
+  using named::t_uint32;
+
+namespace
+{
+  struct t_domain_ {
+    t_domain_id id_;
+    p_what      what_;
+  };
+
+  struct t_site_ {
+    t_site_id   id_;
+    const char* file_;
+  };
+
+  t_domain_ domains_[MAX_DOMAINS];
+  t_uint32  domains_n_ = 0;
+  t_site_   sites_[MAX_SITES];
+  t_uint32  sites_n_ = 0;
+
+  inline t_site_id hash_(const char* str) {
+    t_uint32 hash = 2166136261u;
+    for (; *str; ++str)
+      hash = (hash ^ static_cast<unsigned char>(*str)) * 16777619u;
+    return hash ? hash : 1; // 0 means no site
+  }
+}
+
+  t_bool register_domain(t_domain_id id, p_what what) {
+    if (!id || !what || domains_n_ == MAX_DOMAINS)
+      return false;
+    for (t_uint32 ix = 0; ix < domains_n_; ++ix)
+      if (domains_[ix].id_ == id || domains_[ix].what_ == what)
+        return domains_[ix].id_ == id && domains_[ix].what_ == what;
+    domains_[domains_n_++] = t_domain_{id, what};
+    return true;
+  }
+
+  t_site_id register_site(P_filename filename) {
+    const char* file = get(filename);
+    if (!file)
+      return 0;
+    const t_site_id id = hash_(file);
+    for (t_uint32 ix = 0; ix < sites_n_; ++ix) {
+      if (sites_[ix].id_ == id) {
+        if (sites_[ix].file_ && !std::strcmp(sites_[ix].file_, file))
+          return id;
+        sites_[ix].file_ = nullptr; // collision: the id names no file
+        return 0;
+      }
+    }
+    if (sites_n_ == MAX_SITES)
+      return 0;
+    sites_[sites_n_++] = t_site_{id, file};
+    return id;
+  }
+
+  t_site_id get_site_id(P_filename filename) {
+    const char* file = get(filename);
+    return file ? hash_(file) : 0;
+  }
+
+  t_bool encode(r_wire wire, R_info info) {
+    if (!info.id_)
+      return false;
+    for (t_uint32 ix = 0; ix < domains_n_; ++ix) {
+      if (domains_[ix].what_ == info.what_) {
+        wire.magic_    = WIRE_MAGIC;
+        wire.version_  = WIRE_VERSION;
+        wire.domain_   = domains_[ix].id_;
+        wire.site_     = get_site_id(info.file_);
+        wire.id_       = info.id_;
+        wire.tag_      = info.tag_;
+        wire.depth_    = info.depth_;
+        wire.line_     = info.line_;
+        wire.reserved_ = 0;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  t_bool decode(r_info info, R_wire wire, t_depth* remote_depth) {
+    if (wire.magic_ != WIRE_MAGIC || wire.version_ != WIRE_VERSION ||
+        !wire.id_)
+      return false;
+    for (t_uint32 ix = 0; ix < domains_n_; ++ix) {
+      if (domains_[ix].id_ == wire.domain_) {
+        const char* file = nullptr;
+        for (t_uint32 jx = 0; wire.site_ && jx < sites_n_; ++jx) {
+          if (sites_[jx].id_ == wire.site_) {
+            file = sites_[jx].file_;
+            break;
+          }
+        }
+#ifdef DAINTY_OOPS_BREADCRUMB
+        info.crumbs_.reset();
+#endif
+        info.set(wire.id_, domains_[ix].what_, 0, wire.tag_,
+                 P_filename{file}, wire.line_);
+        if (remote_depth)
+          *remote_depth = wire.depth_;
+        return true;
+      }
+    }
+    return false;
+  }
+}
+}
@@ -0,0 +1,111 @@
+/******************************************************************************
+
+ MIT License
+
+ Copyright (c) 2018 kieme, frits.germs@gmx.net
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+******************************************************************************/
+
+#ifndef _DAINTY_OOPS_WIRE_H_
+#define _DAINTY_OOPS_WIRE_H_
+
+// wire format: a t_info that can cross a process boundary.
+//
+//   t_wire is a fixed size (24 bytes), versioned, trivially copyable record
+//   that can be placed directly in a shared memory queue or sent over a
+//   unix socket. pointers are replaced by stable ids:
+//
+//     domain: the p_what is registered with an id chosen by the application,
+//             the same in every process.
+//     site:   the file name is hashed (fnv-1a 32), so no coordination is
+//             needed. a receiver registers the file names it wants back.
+//             when two registered names have the same hash, the second
+//             registration returns 0 and both sites decode without a file.
+//
+//   the fields are in host byte order, the format is meant for processes
+//   on one machine. breadcrumbs are not carried.
+//
+//   the depth of the origin is data only: decode() gives the info depth 0
+//   and hands the remote depth out separately. the receiving t_oops
+//   publishes the info at its own depth, so its clear rules hold.
+//
+//   sender:                            receiver:
+//     register_domain(7, what);          register_domain(7, what);
+//                                        register_site(P_filename{"a.cpp"});
+//     t_wire wire;                       t_info info(nullptr);
+//     if (encode(wire, info))            if (decode(info, wire))
+//       send(&wire, sizeof(wire));         oops = info;
+
+#include "dainty_oops_ctxt.h"
+
+namespace dainty
+{
+namespace oops
+{
+////////////////////////////////////////////////////////////////////////////////
+
+  using t_domain_id = named::t_uint32;
+  using t_site_id   = named::t_uint32;
+
+  enum {
+    WIRE_MAGIC   = 0x4f57, // "WO"
+    WIRE_VERSION = 1,
+    MAX_DOMAINS  = 64,
+    MAX_SITES    = 256
+  };
+
+  struct t_wire {
+    named::t_uint16 magic_;
+    named::t_uint16 version_;
+    t_domain_id     domain_;
+    t_site_id       site_;
+    t_id            id_;
+    t_tagid         tag_;
+    t_depth         depth_;
+    t_lineno        line_;
+    named::t_uint16 reserved_;
+  };
+
+  static_assert(sizeof(t_wire) == 24, "t_wire layout changed");
+
+  using r_wire = named::t_prefix<t_wire>::r_;
+  using R_wire = named::t_prefix<t_wire>::R_;
+
+////////////////////////////////////////////////////////////////////////////////
+
+  // registration is not thread safe, do it before encode/decode are used.
+  // register_site() returns 0 when the table is full or on a collision.
+  t_bool    register_domain(t_domain_id, p_what);
+  t_site_id register_site  (P_filename);
+
+  t_site_id get_site_id(P_filename);
+
+  // false when the domain of the info is not registered or it is not set.
+  t_bool encode(r_wire, R_info);
+
+  // false when the version or domain is unknown. an unknown site decodes to
+  // no file, but the line is kept. ctxt_ of the info is not touched. the
+  // depth of the info is 0, the depth at the origin goes to remote_depth.
+  t_bool decode(r_info, R_wire, t_depth* remote_depth = nullptr);
+}
+}
+
+#endif